@@ -7,6 +7,14 @@
 #include <ctime>
 #include <sstream>
 #include <iomanip>
+#include <cstdlib>
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <unistd.h>
 using namespace std;
 
 // Forward declarations
@@ -21,72 +29,304 @@ string timeToString(time_t t) {
     return string(buffer);
 }
 
+// Bump allocator: hands out memory from large chunks and frees it all at once
+// when destroyed. Nothing allocated here is ever released individually.
+class Arena {
+private:
+    vector<unique_ptr<char[]>> chunks;
+    size_t chunkSize, used, reserved;
+    char* current;
+    size_t left;
+
+public:
+    Arena(size_t chunk = 1 << 20) : chunkSize(chunk), used(0), reserved(0), current(nullptr), left(0) {}
+
+    void* allocate(size_t n, size_t align = alignof(max_align_t)) {
+        size_t pad = (align - reinterpret_cast<uintptr_t>(current) % align) % align;
+        if (!current || pad + n > left) {
+            size_t size = max(chunkSize, n + align);
+            chunks.emplace_back(new char[size]);
+            current = chunks.back().get();
+            left = size;
+            reserved += size;
+            pad = (align - reinterpret_cast<uintptr_t>(current) % align) % align;
+        }
+        char* p = current + pad;
+        current += pad + n;
+        left -= pad + n;
+        used += n;
+        return p;
+    }
+
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+};
+
+typedef uint32_t StringId;
+
+// Deduplicating store for every string in the catalog and accounts: ISBNs,
+// titles, authors, publishers, statuses, names and history dates. Each
+// distinct string is kept once, NUL-terminated, in 1 MiB chunks, and records
+// hold a 4-byte id instead of a std::string. The id encodes the chunk and
+// offset, so no separate index is needed; lookups go through an open-addressed
+// table of ids. Interning is not thread-safe; reading (get) is.
+class StringPool {
+private:
+    static const int offsetBits = 20;
+    static const size_t chunkSize = size_t(1) << offsetBits;
+    static const StringId empty = ~StringId(0);
+
+    vector<unique_ptr<char[]>> chunks;
+    size_t chunkUsed = chunkSize;
+    size_t count = 0;
+    vector<StringId> table;
+
+    static size_t hashOf(const char* s, size_t len) {
+        size_t h = 14695981039346656037ull; // FNV-1a
+        for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+        return h;
+    }
+
+    size_t slotOf(const char* s, size_t len) const {
+        size_t mask = table.size() - 1;
+        for (size_t slot = hashOf(s, len) & mask; ; slot = (slot + 1) & mask) {
+            StringId entry = table[slot];
+            if (entry == empty) return slot;
+            const char* candidate = get(entry);
+            if (memcmp(candidate, s, len) == 0 && candidate[len] == '\0') return slot;
+        }
+    }
+
+    void grow() {
+        vector<StringId> old(max<size_t>(1024, table.size() * 2), empty);
+        old.swap(table);
+        for (StringId entry : old) {
+            if (entry != empty) table[slotOf(get(entry), strlen(get(entry)))] = entry;
+        }
+    }
+
+public:
+    // Only mutates the pool when s is new, so interning strings known to be
+    // present is safe alongside readers.
+    StringId intern(const char* s, size_t len) {
+        if (len >= chunkSize) throw length_error("string too long for the string pool");
+        if (table.empty()) grow();
+        size_t slot = slotOf(s, len);
+        if (table[slot] != empty) return table[slot];
+        if ((count + 1) * 4 >= table.size() * 3) { // load factor 3/4
+            grow();
+            slot = slotOf(s, len);
+        }
+
+        if (chunkUsed + len + 1 > chunkSize) {
+            if (chunks.size() >= (size_t(1) << (32 - offsetBits))) throw length_error("string pool is full");
+            chunks.emplace_back(new char[chunkSize]);
+            chunkUsed = 0;
+        }
+        StringId id = StringId((chunks.size() - 1) << offsetBits | chunkUsed);
+        memcpy(chunks.back().get() + chunkUsed, s, len);
+        chunks.back()[chunkUsed + len] = '\0';
+        chunkUsed += len + 1;
+        count++;
+        table[slot] = id;
+        return id;
+    }
+
+    StringId intern(const string& s) { return intern(s.data(), s.size()); }
+
+    // Looks a string up without adding it.
+    bool find(const string& s, StringId& id) const {
+        if (table.empty()) return false;
+        StringId entry = table[slotOf(s.data(), s.size())];
+        if (entry != empty) id = entry;
+        return entry != empty;
+    }
+
+    const char* get(StringId id) const { return chunks[id >> offsetBits].get() + (id & (chunkSize - 1)); }
+    size_t size() const { return count; }
+    // Characters stored (including chunk tails left unused by earlier chunks)
+    // plus one table slot per string; what a record is charged for.
+    size_t bytesUsed() const {
+        return chunks.empty() ? 0 : (chunks.size() - 1) * chunkSize + chunkUsed + count * sizeof(StringId);
+    }
+    // Everything allocated: whole chunks and the full table.
+    size_t bytesReserved() const { return chunks.size() * chunkSize + table.capacity() * sizeof(StringId); }
+};
+
+StringPool& stringPool() {
+    static StringPool pool;
+    return pool;
+}
+
+// Fixed-size block allocator with one free list per 8-byte size class, carving
+// blocks out of an arena. It backs User objects and account records, which are
+// small, numerous and similar in size. Not thread-safe.
+class BlockPool {
+private:
+    static const size_t granularity = 8, maxBlock = 256;
+    Arena slabs{1 << 16};
+    void* freeLists[maxBlock / granularity + 1] = {};
+    size_t inUse = 0, largeInUse = 0; // inUse includes largeInUse
+
+public:
+    // Bytes actually taken by a request for n; blocks over maxBlock go to
+    // ::operator new unrounded but are still counted.
+    static size_t blockSize(size_t n) {
+        if (n == 0) return 0;
+        if (n > maxBlock) return n;
+        return (max(n, granularity) + granularity - 1) / granularity * granularity;
+    }
+
+    void* allocate(size_t n) {
+        n = blockSize(n);
+        inUse += n;
+        if (n > maxBlock) {
+            largeInUse += n;
+            return ::operator new(n);
+        }
+        void*& head = freeLists[n / granularity];
+        if (head) {
+            void* block = head;
+            head = *static_cast<void**>(block);
+            return block;
+        }
+        return slabs.allocate(n, granularity);
+    }
+
+    void deallocate(void* p, size_t n) {
+        if (!p) return;
+        n = blockSize(n);
+        inUse -= n;
+        if (n > maxBlock) {
+            largeInUse -= n;
+            ::operator delete(p);
+            return;
+        }
+        void*& head = freeLists[n / granularity];
+        *static_cast<void**>(p) = head;
+        head = p;
+    }
+
+    size_t bytesInUse() const { return inUse; }
+    size_t bytesReserved() const { return slabs.bytesReserved() + largeInUse; }
+};
+
+BlockPool& blockPool() {
+    static BlockPool pool;
+    return pool;
+}
+
+// Standard allocator adaptor so containers can draw from the block pool.
+template<typename T>
+struct PoolAllocator {
+    typedef T value_type;
+    PoolAllocator() = default;
+    template<typename U> PoolAllocator(const PoolAllocator<U>&) {}
+    T* allocate(size_t n) { return static_cast<T*>(blockPool().allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { blockPool().deallocate(p, n * sizeof(T)); }
+};
+template<typename T, typename U> bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) { return true; }
+template<typename T, typename U> bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) { return false; }
+
+// Resident set size of this process in bytes, or 0 where /proc is unavailable.
+size_t residentBytes() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) return stoul(line.substr(6)) * 1024;
+    }
+    return 0;
+}
+
 class Book {
 private:
-    string title, author, publisher, ISBN;
+    StringId title, author, publisher, ISBN;
+    StringId status; // Available, Borrowed, Reserved
     int year;
-    string status; // Available, Borrowed, Reserved
 
 public:
-    Book(string t, string a, string p, string i, int y, string s = "Available")
-        : title(t), author(a), publisher(p), ISBN(i), year(y), status(s) {}
+    Book(const string& t, const string& a, const string& p, const string& i, int y, const string& s = "Available")
+        : title(stringPool().intern(t)), author(stringPool().intern(a)), publisher(stringPool().intern(p)),
+          ISBN(stringPool().intern(i)), status(stringPool().intern(s)), year(y) {}
 
     // Getters
-    string getTitle() const { return title; }
-    string getAuthor() const { return author; }
-    string getPublisher() const { return publisher; }
-    string getISBN() const { return ISBN; }
+    string getTitle() const { return stringPool().get(title); }
+    string getAuthor() const { return stringPool().get(author); }
+    string getPublisher() const { return stringPool().get(publisher); }
+    string getISBN() const { return stringPool().get(ISBN); }
+    StringId getISBNId() const { return ISBN; }
     int getYear() const { return year; }
-    string getStatus() const { return status; }
+    string getStatus() const { return stringPool().get(status); }
 
-    void setStatus(const string& s) { status = s; }
+    void setStatus(const string& s) { status = stringPool().intern(s); }
 
     string serialize() const {
-        return ISBN + "," + title + "," + author + "," + publisher + "," +
-               to_string(year) + "," + status;
+        return getISBN() + "," + getTitle() + "," + getAuthor() + "," + getPublisher() + "," +
+               to_string(year) + "," + getStatus();
     }
 
+    // Splits in place rather than through a stringstream; loading millions of
+    // books is dominated by this.
     static Book deserialize(const string& data) {
-        stringstream ss(data);
         string parts[6];
-        for (int i = 0; i < 6; i++) getline(ss, parts[i], ',');
+        size_t start = 0;
+        for (int i = 0; i < 6; i++) {
+            size_t end = i < 5 ? data.find(',', start) : string::npos;
+            if (start <= data.size()) parts[i] = data.substr(start, end == string::npos ? string::npos : end - start);
+            start = end == string::npos ? data.size() + 1 : end + 1;
+        }
         return Book(parts[1], parts[2], parts[3], parts[0], stoi(parts[4]), parts[5]);
     }
 };
 
+// A loan the account currently holds.
+struct Loan {
+    StringId isbn;
+    time_t due;
+};
+
+// One borrowing record; dates are kept as the strings they are shown as
+// ("2024-01-03", "Not Returned", ...), which repeat across accounts and so pool well.
+struct HistoryEntry {
+    StringId isbn, due, returned;
+};
+
+typedef vector<Loan, PoolAllocator<Loan>> LoanList;
+typedef vector<HistoryEntry, PoolAllocator<HistoryEntry>> HistoryList;
+
+StringId notReturnedId() {
+    static StringId id = stringPool().intern("Not Returned");
+    return id;
+}
+
 class Account {
 private:
-    vector<pair<string, time_t>> borrowedBooks;
-    vector<string> borrowingHistory;
+    LoanList borrowedBooks;
+    HistoryList borrowingHistory;
     double fine;
 
 public:
     Account() : fine(0.0) {}
 
     void addBook(const string& ISBN, time_t dueDate) {
-        borrowedBooks.emplace_back(ISBN, dueDate);
-        string dueDateStr = timeToString(dueDate);  
-        borrowingHistory.push_back(ISBN + "|" + dueDateStr + "|Not Returned");
+        StringId isbn = stringPool().intern(ISBN);
+        borrowedBooks.push_back(Loan{isbn, dueDate});
+        borrowingHistory.push_back(HistoryEntry{isbn, stringPool().intern(timeToString(dueDate)), notReturnedId()});
     }
 
     bool removeBook(const string& ISBN, time_t returnDate) {
+        StringId isbn;
+        if (!stringPool().find(ISBN, isbn)) return false;
         auto it = find_if(borrowedBooks.begin(), borrowedBooks.end(),
-            [&ISBN](const pair<string, time_t>& b) { return b.first == ISBN; });
+            [isbn](const Loan& b) { return b.isbn == isbn; });
     
         if (it != borrowedBooks.end()) {
-            time_t dueDate = it->second;
-            string dueDateStr = timeToString(dueDate);  
-            string returnDateStr = timeToString(returnDate);  
+            time_t dueDate = it->due;
+            StringId returned = stringPool().intern(timeToString(returnDate));
     
-            for (string& entry : borrowingHistory) {
-                stringstream ss(entry);
-                string recordedISBN, storedDueDate, returned;
-                getline(ss, recordedISBN, '|');
-                getline(ss, storedDueDate, '|');
-                getline(ss, returned);
-    
-                if (recordedISBN == ISBN && returned == "Not Returned") {
-                    entry = ISBN + "|" + storedDueDate + "|" + returnDateStr;
+            for (HistoryEntry& entry : borrowingHistory) {
+                if (entry.isbn == isbn && entry.returned == notReturnedId()) {
+                    entry.returned = returned;
                     break;
                 }
             }
@@ -114,8 +354,64 @@ public:
             fine = 0.0;
         }
     }
-    vector<pair<string, time_t>> getBorrowedBooks() const { return borrowedBooks; }
-    vector<string> getHistory() const { return borrowingHistory; }
+    const LoanList& getBorrowedBooks() const { return borrowedBooks; }
+    const HistoryList& getHistory() const { return borrowingHistory; }
+
+    bool hasBorrowed(StringId isbn) const {
+        return any_of(borrowedBooks.begin(), borrowedBooks.end(), [isbn](const Loan& b) { return b.isbn == isbn; });
+    }
+
+    // Bytes held by this account's records, as allocated from the block pool.
+    size_t recordBytes() const {
+        return BlockPool::blockSize(borrowedBooks.capacity() * sizeof(Loan)) +
+               BlockPool::blockSize(borrowingHistory.capacity() * sizeof(HistoryEntry));
+    }
+
+    // Repair hook for the consistency checker: drops loan records for ISBN
+    // without charging a fine and closes its open history entries with
+    // `marker`. With keepOne, the earliest-due loan survives along with the
+    // open history entry for it (the one showing its due date, else the
+    // first open one). Returns the number of records changed.
+    int releaseBook(StringId isbn, const string& marker, bool keepOne) {
+        int changed = 0;
+        auto keep = borrowedBooks.end();
+        if (keepOne) {
+            for (auto it = borrowedBooks.begin(); it != borrowedBooks.end(); ++it) {
+                if (it->isbn == isbn && (keep == borrowedBooks.end() || it->due < keep->due)) keep = it;
+            }
+        }
+        const size_t none = SIZE_MAX;
+        size_t keptHistory = none;
+        if (keepOne) {
+            StringId keptDue;
+            bool haveDue = keep != borrowedBooks.end() && stringPool().find(timeToString(keep->due), keptDue);
+            for (size_t i = 0; i < borrowingHistory.size(); i++) {
+                const HistoryEntry& entry = borrowingHistory[i];
+                if (entry.isbn != isbn || entry.returned != notReturnedId()) continue;
+                if (keptHistory == none) keptHistory = i;
+                if (haveDue && entry.due == keptDue) {
+                    keptHistory = i;
+                    break;
+                }
+            }
+        }
+
+        LoanList remaining;
+        for (auto it = borrowedBooks.begin(); it != borrowedBooks.end(); ++it) {
+            if (it->isbn != isbn || it == keep) remaining.push_back(*it);
+            else changed++;
+        }
+        borrowedBooks.swap(remaining);
+
+        StringId markerId = stringPool().intern(marker);
+        for (size_t i = 0; i < borrowingHistory.size(); i++) {
+            HistoryEntry& entry = borrowingHistory[i];
+            if (entry.isbn != isbn || entry.returned != notReturnedId() || i == keptHistory) continue;
+            entry.returned = markerId;
+            changed++;
+        }
+        return changed;
+    }
 
     string serialize() const {
         stringstream ss;
@@ -123,13 +419,14 @@ public:
         // Serialize borrowed books
         ss << borrowedBooks.size() << ";";
         for (const auto& entry : borrowedBooks) {
-            ss << entry.first << "," << entry.second << ";";
+            ss << stringPool().get(entry.isbn) << "," << entry.due << ";";
         }
         
         // Serialize borrowing history
         ss << borrowingHistory.size() << ";";
         for (const auto& entry : borrowingHistory) {
-            ss << entry << ";";
+            ss << stringPool().get(entry.isbn) << "|" << stringPool().get(entry.due) << "|"
+               << stringPool().get(entry.returned) << ";";
         }
     
         // Serialize fine
@@ -143,12 +440,12 @@ public:
         borrowingHistory.clear();
         fine = 0.0;
     
-        stringstream ss(data);
-        string part;
         vector<string> parts;
-    
-        while (getline(ss, part, ';')) {
-            if (!part.empty()) parts.push_back(part);
+        for (size_t start = 0; start < data.size(); ) {
+            size_t end = data.find(';', start);
+            if (end == string::npos) end = data.size();
+            if (end > start) parts.push_back(data.substr(start, end - start));
+            start = end + 1;
         }
     
         size_t index = 0;
@@ -158,12 +455,13 @@ public:
             // Load borrowed books
             if (index < parts.size()) {
                 int borrowedCount = stoi(parts[index++]);
+                borrowedBooks.reserve(max(borrowedCount, 0));
                 for (int i = 0; i < borrowedCount && index < parts.size(); i++) {
-                    stringstream entryStream(parts[index++]);
-                    string isbn, dueDateStr;
-                    if (getline(entryStream, isbn, ',') && getline(entryStream, dueDateStr)) {
-                        time_t dueDate = stol(dueDateStr);
-                        borrowedBooks.emplace_back(isbn, dueDate);
+                    const string& entry = parts[index++];
+                    size_t comma = entry.find(',');
+                    if (comma != string::npos && comma + 1 < entry.size()) {
+                        time_t dueDate = stol(entry.substr(comma + 1));
+                        borrowedBooks.push_back(Loan{stringPool().intern(entry.data(), comma), dueDate});
                     }
                 }
             }
@@ -171,21 +469,23 @@ public:
             // Load borrowing history
             if (index < parts.size()) {
                 int historyCount = stoi(parts[index++]);
+                borrowingHistory.reserve(max(historyCount, 0));
                 for (int i = 0; i < historyCount && index < parts.size(); i++) {
-                    string entry = parts[index++];
+                    const string& entry = parts[index++];
                     
-                    stringstream historyStream(entry);
-                    string isbn, dueDate, returnDate;
-    
-                    getline(historyStream, isbn, '|');
-                    getline(historyStream, dueDate, '|');
-                    getline(historyStream, returnDate);
+                    size_t first = entry.find('|');
+                    size_t second = first == string::npos ? string::npos : entry.find('|', first + 1);
+                    string isbn = entry.substr(0, first);
+                    string dueDate = first == string::npos ? "" :
+                        entry.substr(first + 1, second == string::npos ? string::npos : second - first - 1);
+                    string returnDate = second == string::npos ? "" : entry.substr(second + 1);
+                    StringId isbnId = stringPool().intern(isbn);
     
                     // **Fix: If dueDate is empty, extract it from borrowedBooks**
                     if (dueDate.empty() || dueDate == "Unknown") {
                         for (const auto& borrowed : borrowedBooks) {
-                            if (borrowed.first == isbn) {
-                                dueDate = timeToString(borrowed.second);
+                            if (borrowed.isbn == isbnId) {
+                                dueDate = timeToString(borrowed.due);
                                 break;
                             }
                         }
@@ -194,7 +494,8 @@ public:
                     // If no return date, mark as "Not Returned"
                     if (returnDate.empty()) returnDate = "Not Returned";
     
-                    borrowingHistory.push_back(isbn + "|" + dueDate + "|" + returnDate);
+                    borrowingHistory.push_back(HistoryEntry{isbnId, stringPool().intern(dueDate),
+                                                            stringPool().intern(returnDate)});
                 }
             }
     
@@ -214,18 +515,23 @@ public:
 
 class User {
 protected:
-    string name;
+    StringId name;
     int id;
     Account account;
 
 public:
-    User(string n, int i) : name(n), id(i) {}
+    User(const string& n, int i) : name(stringPool().intern(n)), id(i) {}
     virtual ~User() = default;
 
+    // Users are drawn from the block pool rather than allocated one by one.
+    static void* operator new(size_t size) { return blockPool().allocate(size); }
+    static void operator delete(void* p, size_t size) { blockPool().deallocate(p, size); }
+
     // Getters
-    string getName() const { return name; }
+    string getName() const { return stringPool().get(name); }
     int getId() const { return id; }
     Account& getAccount() { return account; }
+    const Account& getAccount() const { return account; }
 
     // Pure virtual functions
     virtual void borrowBook(Book& book) = 0;
@@ -245,7 +551,7 @@ public:
     bool hasOverdueBooks(int maxDays = 0) const {
         time_t now = getCurrentTime();
         for (const auto& entry : account.getBorrowedBooks()) {
-            double daysOverdue = difftime(now, entry.second) / (60 * 60 * 24);
+            double daysOverdue = difftime(now, entry.due) / (60 * 60 * 24);
             if (daysOverdue > maxDays) return true;
         }
         return false;
@@ -330,7 +636,7 @@ public:
     void returnBook(Book& book) override { cout << "Librarians cannot return books.\n"; }
 
     void displayMenu() override {
-        cout << "\nLibrarian Menu\n1. Add Book\n2. Remove Book\n3. Add User\n4. Remove User\n5. View All Books\n6. Change Book Status\n7. Exit\nChoice: ";
+        cout << "\nLibrarian Menu\n1. Add Book\n2. Remove Book\n3. Add User\n4. Remove User\n5. View All Books\n6. Change Book Status\n7. Check Consistency\n8. Exit\nChoice: ";
     }
 
     void addBook(vector<Book>& books, const Book& newBook) {
@@ -371,75 +677,551 @@ public:
     string getType() const override { return "Librarian"; }
 };
 
-class LibrarySystem {
+unique_ptr<User> createUser(const string& type, const string& name, int id) {
+    if (type == "Student") return make_unique<Student>(name, id);
+    if (type == "Faculty") return make_unique<Faculty>(name, id);
+    if (type == "Librarian") return make_unique<Librarian>(name, id);
+    return nullptr;
+}
+
+string serializeUser(const User& user) {
+    return user.getType() + "|" + user.getName() + "|" + to_string(user.getId()) +
+           "|" + user.getAccount().serialize();
+}
+
+// Account data itself contains '|' (history entries), so only the first three
+// fields are split off and the remainder of the line is the account.
+unique_ptr<User> deserializeUser(const string& line) {
+    size_t typeEnd = line.find('|');
+    size_t nameEnd = typeEnd == string::npos ? string::npos : line.find('|', typeEnd + 1);
+    if (nameEnd == string::npos) return nullptr;
+    size_t idEnd = line.find('|', nameEnd + 1);
+
+    string type = line.substr(0, typeEnd);
+    string name = line.substr(typeEnd + 1, nameEnd - typeEnd - 1);
+    string idStr = line.substr(nameEnd + 1, idEnd == string::npos ? string::npos : idEnd - nameEnd - 1);
+    string accountData = idEnd == string::npos ? "" : line.substr(idEnd + 1);
+
+    int id;
+    try {
+        id = stoi(idStr);
+    } catch (const exception& e) {
+        return nullptr;
+    }
+
+    unique_ptr<User> user = createUser(type, name, id);
+    if (!user) return nullptr;
+
+    try {
+        if (!accountData.empty()) {
+            user->getAccount().deserialize(accountData);
+        }
+    } catch (const exception& e) {
+        cerr << "Error loading account for user " << id << ": " << e.what() << endl;
+    }
+    return user;
+}
+
+void loadBooks(const string& path, vector<Book>& books) {
+    ifstream file(path);
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back(); // CRLF data files
+        if (line.empty()) continue;
+        books.push_back(Book::deserialize(line));
+    }
+    books.shrink_to_fit(); // drop the growth slack; the catalog is mostly read from here on
+}
+
+void saveBooks(const string& path, const vector<Book>& books) {
+    ofstream file(path);
+    for (const auto& book : books) {
+        file << book.serialize() << endl;
+    }
+}
+
+void loadUsers(const string& path, vector<unique_ptr<User>>& users) {
+    ifstream file(path);
+    if (!file) return;
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        unique_ptr<User> user = deserializeUser(line);
+        if (user) users.push_back(std::move(user));
+    }
+    users.shrink_to_fit();
+}
+
+void saveUsers(const string& path, const vector<unique_ptr<User>>& users) {
+    ofstream file(path);
+    for (const auto& user : users) {
+        file << serializeUser(*user) << endl;
+    }
+}
+
+// Position in the change stream: the last sequence number covered, the
+// byte offset just past it, and the primary's timestamp on that record.
+struct StreamOffset {
+    long seq = 0;
+    long bytes = 0;
+    time_t time = 0;
+};
+
+bool loadStreamOffset(const string& path, StreamOffset& offset) {
+    ifstream file(path);
+    if (!(file >> offset.seq >> offset.bytes)) return false;
+    long time;
+    if (file >> time) offset.time = time; // absent in offsets written before it was tracked
+    return true;
+}
+
+void saveStreamOffset(const string& path, const StreamOffset& offset) {
+    ofstream file(path);
+    file << offset.seq << " " << offset.bytes << " " << (long)offset.time << endl;
+}
+
+// Positions of books by ISBN id and users by ID, so applying a change record
+// is a lookup rather than a scan of the whole catalog.
+struct RecordIndex {
+    unordered_map<StringId, size_t> books;
+    unordered_map<int, size_t> users;
+
+    void rebuild(const vector<Book>& bookList, const vector<unique_ptr<User>>& userList) {
+        books.clear();
+        users.clear();
+        books.reserve(bookList.size());
+        users.reserve(userList.size());
+        for (size_t i = 0; i < bookList.size(); i++) books.emplace(bookList[i].getISBNId(), i);
+        for (size_t i = 0; i < userList.size(); i++) users.emplace(userList[i]->getId(), i);
+    }
+
+    // Entries after an erased position move down by one.
+    template<typename Map>
+    static void shiftAfter(Map& map, size_t erased) {
+        for (auto& entry : map) {
+            if (entry.second > erased) entry.second--;
+        }
+    }
+};
+
+// Applies one change record to an in-memory catalog and user list, keeping
+// index in step. Records carry full state, so applying one that is already
+// reflected is harmless. Upserts are O(1); deletes shift the vectors and are O(n).
+void applyChange(const string& kind, const string& payload, vector<Book>& books,
+                 vector<unique_ptr<User>>& users, RecordIndex& index) {
+    if (kind == "BOOK") {
+        Book book = Book::deserialize(payload);
+        auto found = index.books.find(book.getISBNId());
+        if (found != index.books.end()) {
+            books[found->second] = book;
+        } else {
+            index.books.emplace(book.getISBNId(), books.size());
+            books.push_back(book);
+        }
+    } else if (kind == "DELBOOK") {
+        StringId isbn;
+        if (!stringPool().find(payload, isbn)) return;
+        auto found = index.books.find(isbn);
+        if (found == index.books.end()) return;
+        size_t position = found->second;
+        books.erase(books.begin() + position);
+        index.books.erase(found);
+        RecordIndex::shiftAfter(index.books, position);
+    } else if (kind == "USER") {
+        unique_ptr<User> user = deserializeUser(payload);
+        if (!user) return;
+        auto found = index.users.find(user->getId());
+        if (found != index.users.end()) {
+            users[found->second] = std::move(user);
+        } else {
+            index.users.emplace(user->getId(), users.size());
+            users.push_back(std::move(user));
+        }
+    } else if (kind == "DELUSER") {
+        auto found = index.users.find(stoi(payload));
+        if (found == index.users.end()) return;
+        size_t position = found->second;
+        users.erase(users.begin() + position);
+        index.users.erase(found);
+        RecordIndex::shiftAfter(index.users, position);
+    }
+}
+
+// Applies every complete change record in the log past `at` and advances it.
+// A record without its trailing newline is still being written and is left
+// for next time. Returns the size of the log, or -1 if there is none.
+long replayChanges(const string& path, StreamOffset& at, vector<Book>& books, vector<unique_ptr<User>>& users,
+                   RecordIndex& index) {
+    ifstream file(path);
+    if (!file) return -1;
+    file.seekg(0, ios::end);
+    long size = file.tellg();
+    if (size < at.bytes) {
+        // Replaced or truncated: rescan it, still skipping sequence numbers already applied.
+        cerr << "Change stream " << path << " is shorter than the saved offset; rescanning it.\n";
+        at.bytes = 0;
+    }
+    file.seekg(at.bytes);
+
+    string line;
+    while (getline(file, line)) {
+        if (file.eof()) break;
+        long next = file.tellg();
+
+        size_t seqEnd = line.find('|');
+        size_t timeEnd = seqEnd == string::npos ? string::npos : line.find('|', seqEnd + 1);
+        size_t kindEnd = timeEnd == string::npos ? string::npos : line.find('|', timeEnd + 1);
+        long seq = atol(line.c_str());
+        if (kindEnd != string::npos && seq > at.seq) {
+            if (seq != at.seq + 1) {
+                cerr << "Change stream gap: expected " << at.seq + 1 << ", got " << seq << endl;
+            }
+            try {
+                applyChange(line.substr(timeEnd + 1, kindEnd - timeEnd - 1), line.substr(kindEnd + 1), books, users, index);
+            } catch (const exception& e) {
+                cerr << "Error applying change " << seq << ": " << e.what() << endl;
+            }
+            at.seq = seq;
+            at.time = atol(line.c_str() + seqEnd + 1);
+        }
+        at.bytes = next;
+    }
+    return size;
+}
+
+// Ordered, append-only log of catalog and account mutations written by the
+// primary. Each record is one line: "seq|timestamp|kind|payload", where kind is
+// BOOK (payload: serialized book), DELBOOK (ISBN), USER (serialized user) or
+// DELUSER (ID). Records carry full state, so replaying one twice is harmless.
+class ChangeStream {
 private:
-    vector<Book> books;
-    vector<unique_ptr<User>> users;
-    User* currentUser = nullptr;
+    string path;
+    StreamOffset head;
+
+public:
+    ChangeStream(const string& p) : path(p) {}
+
+    // Continues numbering after `last`, which must cover every record in the log.
+    void resumeAfter(const StreamOffset& last) { head = last; }
 
-    void loadBooks() {
-        ifstream file("books.txt");
-        string line;
-        while (getline(file, line)) {
-            books.push_back(Book::deserialize(line));
+    void publish(const string& kind, const string& payload) {
+        time_t now = getCurrentTime();
+        stringstream record;
+        record << (head.seq + 1) << "|" << now << "|" << kind << "|" << payload << "\n";
+        ofstream file(path, ios::app);
+        file << record.str();
+        file.flush();
+        if (!file) {
+            cerr << "Error writing change stream " << path << endl;
+            return;
         }
+        // Take the offset from the file itself so it stays exact even if
+        // something else touched the log since the last append.
+        long end = file.tellp();
+        head.seq++;
+        head.bytes = end >= 0 ? end : head.bytes + (long)record.str().size();
+        head.time = now;
     }
 
-    void saveBooks() {
-        ofstream file("books.txt");
-        for (const auto& book : books) {
-            file << book.serialize() << endl;
+    StreamOffset getHead() const { return head; }
+};
+
+struct ConsistencyReport {
+    vector<string> doubleLoans, orphans, statusMismatches, unrecordedLoans;
+    vector<string> duplicateBooks; // ISBNs listed more than once; reported, never repaired
+    size_t loansChecked = 0, historyChecked = 0, historyOrphans = 0;
+    vector<size_t> changedBooks, changedUsers; // indices touched by a repair
+    double seconds = 0;
+
+    size_t issueCount() const {
+        return doubleLoans.size() + orphans.size() + statusMismatches.size() + unrecordedLoans.size() +
+               duplicateBooks.size();
+    }
+};
+
+// Joins every account's loan and history records against the catalog. Both
+// sides are hash-partitioned by ISBN across all cores, then each partition is
+// joined independently, so the whole check is linear in books + records.
+class ConsistencyChecker {
+private:
+    // Everything one account holds for one ISBN.
+    struct Claim {
+        size_t user;
+        time_t due;
+        StringId isbn;
+        int borrowed;    // loan records
+        int openHistory; // "Not Returned" history entries
+        int closedHistory;
+    };
+
+    struct Release {
+        size_t user;
+        StringId isbn;
+        bool keepOne;
+    };
+
+    struct Partition {
+        ConsistencyReport report;
+        vector<Release> releases;
+    };
+
+    // ISBNs are interned, so equal ISBNs share an id. Ids are chunk offsets with
+    // regular strides, though, so they are mixed (Fibonacci hashing) before
+    // taking the modulus to keep partitions, and so workers, evenly loaded.
+    static size_t partitionOf(StringId isbn, size_t parts) {
+        return (size_t)((isbn * 0x9E3779B97F4A7C15ull) >> 32) % parts;
+    }
+
+    // Runs f(worker, begin, end) over [0, n) split into one contiguous range per worker.
+    template<typename F>
+    static void parallelFor(size_t n, size_t workers, F f) {
+        vector<thread> pool;
+        for (size_t w = 0; w < workers; w++) {
+            size_t begin = n * w / workers, end = n * (w + 1) / workers;
+            pool.emplace_back([=, &f]() { f(w, begin, end); });
         }
+        for (auto& t : pool) t.join();
     }
 
-    void loadUsers() {
-        ifstream file("users.txt");
-        if (!file) return;
-        string line;
-        while (getline(file, line)) {
-            vector<string> userParts;
-            stringstream ss(line);
-            string part;
-    
-            while (getline(ss, part, '|')) {
-                userParts.push_back(part);
+    static void collectClaims(const User& user, size_t index, vector<Claim>& claims) {
+        // Typical accounts hold a handful of records, where a scan of the claims
+        // so far is fastest; larger ones get a map so each account stays linear.
+        // The map is per account so its size never carries over to the next.
+        const size_t scanLimit = 16;
+        const Account& account = user.getAccount();
+        bool large = account.getBorrowedBooks().size() + account.getHistory().size() > scanLimit;
+        unordered_map<StringId, size_t> positions;
+        size_t start = claims.size();
+        auto claimFor = [&](StringId isbn) -> Claim& {
+            if (large) {
+                auto inserted = positions.emplace(isbn, claims.size());
+                if (!inserted.second) return claims[inserted.first->second];
+            } else {
+                for (size_t i = start; i < claims.size(); i++) {
+                    if (claims[i].isbn == isbn) return claims[i];
+                }
             }
-    
-            if (userParts.size() < 4) {
-                if (userParts.size() != 3) continue;
-                userParts.push_back("");
+            claims.push_back(Claim{index, 0, isbn, 0, 0, 0});
+            return claims.back();
+        };
+
+        for (const Loan& loan : account.getBorrowedBooks()) {
+            Claim& claim = claimFor(loan.isbn);
+            if (claim.borrowed == 0 || loan.due < claim.due) claim.due = loan.due;
+            claim.borrowed++;
+        }
+        StringId notReturned = notReturnedId();
+        for (const HistoryEntry& entry : account.getHistory()) {
+            Claim& claim = claimFor(entry.isbn);
+            if (entry.returned == notReturned) claim.openHistory++;
+            else claim.closedHistory++;
+        }
+    }
+
+    static string userLabel(const vector<unique_ptr<User>>& users, size_t index) {
+        return to_string(users[index]->getId());
+    }
+
+    static void joinPartition(vector<Book>& books, const vector<unique_ptr<User>>& users,
+                              const vector<vector<vector<size_t>>>& bookParts,
+                              const vector<vector<vector<Claim>>>& claimParts,
+                              size_t p, bool repair, Partition& out) {
+        ConsistencyReport& report = out.report;
+
+        // Build side: ISBN -> slot, one slot per catalog book in this partition.
+        size_t bookCount = 0;
+        for (const auto& worker : bookParts) bookCount += worker[p].size();
+        unordered_map<StringId, size_t> catalog;
+        catalog.reserve(bookCount);
+        vector<size_t> slotBook;
+        slotBook.reserve(bookCount);
+        for (const auto& worker : bookParts) {
+            for (size_t index : worker[p]) {
+                if (catalog.emplace(books[index].getISBNId(), slotBook.size()).second) {
+                    slotBook.push_back(index);
+                } else {
+                    report.duplicateBooks.push_back(books[index].getISBN() + ": listed more than once in the catalog");
+                }
             }
-    
-            string type = userParts[0];
-            string name = userParts[1];
-            int id = stoi(userParts[2]);
-            string accountData = userParts[3];
-    
-            unique_ptr<User> user;
-            if (type == "Student") user = make_unique<Student>(name, id);
-            else if (type == "Faculty") user = make_unique<Faculty>(name, id);
-            else if (type == "Librarian") user = make_unique<Librarian>(name, id);
-            else continue;
-    
-            try {
-                if (!accountData.empty()) {
-                    user->getAccount().deserialize(accountData);
+        }
+
+        // Probe side: chain each holding claim onto its book's slot, indexing
+        // claims by their position across all workers' buckets. A holder is any
+        // claim with a loan record or an open history entry.
+        const size_t none = SIZE_MAX;
+        vector<const Claim*> claims;
+        for (const auto& worker : claimParts) {
+            for (const Claim& claim : worker[p]) claims.push_back(&claim);
+        }
+        vector<size_t> firstHolder(slotBook.size(), none), nextHolder(claims.size(), none);
+        for (size_t c = 0; c < claims.size(); c++) {
+            const Claim& claim = *claims[c];
+            report.loansChecked += claim.borrowed;
+            report.historyChecked += claim.openHistory + claim.closedHistory;
+            auto found = catalog.find(claim.isbn);
+            if (found == catalog.end()) {
+                report.historyOrphans += claim.closedHistory;
+                if (claim.borrowed == 0 && claim.openHistory == 0) continue;
+                report.orphans.push_back(string(stringPool().get(claim.isbn)) + ": held by user " + userLabel(users, claim.user) +
+                                         " but not in the catalog");
+                if (repair) out.releases.push_back(Release{claim.user, claim.isbn, false});
+                continue;
+            }
+            if (claim.borrowed == 0 && claim.openHistory == 0) continue;
+            nextHolder[c] = firstHolder[found->second];
+            firstHolder[found->second] = c;
+        }
+
+        vector<const Claim*> holders;
+        for (size_t slot = 0; slot < slotBook.size(); slot++) {
+            Book& book = books[slotBook[slot]];
+            StringId isbnId = book.getISBNId();
+            string isbn = book.getISBN();
+
+            holders.clear();
+            for (size_t c = firstHolder[slot]; c != none; c = nextHolder[c]) holders.push_back(claims[c]);
+            reverse(holders.begin(), holders.end()); // back to account order
+
+            const Claim* keeper = nullptr;
+            if (!holders.empty()) {
+                for (const Claim* claim : holders) {
+                    if (claim->borrowed > 0 && (!keeper || claim->due < keeper->due)) keeper = claim;
+                    if (claim->borrowed == 0) {
+                        report.unrecordedLoans.push_back(isbn + ": user " + userLabel(users, claim->user) +
+                                                         " has it \"Not Returned\" in history without a loan record");
+                    }
+                }
+                if (holders.size() > 1 || holders[0]->borrowed > 1 || holders[0]->openHistory > 1) {
+                    string line = isbn + ": held by users";
+                    for (const Claim* claim : holders) {
+                        line += " " + userLabel(users, claim->user);
+                        if (claim->borrowed > 1 || claim->openHistory > 1) line += " (duplicated)";
+                    }
+                    report.doubleLoans.push_back(line);
+                }
+                if (repair) {
+                    for (const Claim* claim : holders) {
+                        if (claim != keeper) out.releases.push_back(Release{claim->user, isbnId, false});
+                        else if (claim->borrowed > 1 || claim->openHistory > 1) out.releases.push_back(Release{claim->user, isbnId, true});
+                    }
+                }
+            }
+
+            string status = book.getStatus();
+            string expected;
+            if (keeper) expected = "Borrowed";
+            else if (status == "Borrowed" || (status != "Available" && status != "Reserved")) expected = "Available";
+            else expected = status;
+
+            if (status != expected) {
+                report.statusMismatches.push_back(isbn + ": catalog says " + status + ", loans say " + expected);
+                if (repair) {
+                    book.setStatus(expected);
+                    report.changedBooks.push_back(slotBook[slot]);
                 }
-            } catch (const exception& e) {
-                cerr << "Error loading account for user " << id << ": " << e.what() << endl;
             }
-    
-            users.push_back(std::move(user));
         }
-    }    
+    }
 
-    void saveUsers() {
-        ofstream file("users.txt");
-        for (const auto& user : users) {
-            file << user->getType() << "|" << user->getName() << "|" 
-                 << user->getId() << "|" << user->getAccount().serialize() << endl;
+public:
+    static ConsistencyReport check(vector<Book>& books, vector<unique_ptr<User>>& users, bool repair) {
+        auto started = chrono::steady_clock::now();
+        // Repairs set these statuses from several threads; intern them up front
+        // so those calls only read the pool.
+        for (const char* status : {"Available", "Borrowed", "Reserved"}) stringPool().intern(status);
+        size_t workers = max(1u, thread::hardware_concurrency());
+        // Enough partitions that each one's hash table stays cache-sized.
+        size_t parts = max(workers, books.size() / 16384 + 1);
+
+        // Partition both sides by ISBN hash. Each worker writes only its own buckets.
+        vector<vector<vector<size_t>>> bookParts(workers, vector<vector<size_t>>(parts));
+        vector<vector<vector<Claim>>> claimParts(workers, vector<vector<Claim>>(parts));
+        parallelFor(books.size(), workers, [&](size_t w, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                bookParts[w][partitionOf(books[i].getISBNId(), parts)].push_back(i);
+            }
+        });
+        parallelFor(users.size(), workers, [&](size_t w, size_t begin, size_t end) {
+            vector<Claim> claims;
+            for (size_t i = begin; i < end; i++) {
+                claims.clear();
+                collectClaims(*users[i], i, claims);
+                for (const Claim& claim : claims) {
+                    claimParts[w][partitionOf(claim.isbn, parts)].push_back(claim);
+                }
+            }
+        });
+
+        // Join each partition on its own core. Book status fixes stay within the
+        // partition; account fixes can span partitions and are applied afterwards.
+        vector<Partition> results(parts);
+        parallelFor(parts, workers, [&](size_t, size_t begin, size_t end) {
+            for (size_t p = begin; p < end; p++) {
+                joinPartition(books, users, bookParts, claimParts, p, repair, results[p]);
+            }
+        });
+
+        ConsistencyReport report;
+        for (Partition& part : results) {
+            ConsistencyReport& r = part.report;
+            report.doubleLoans.insert(report.doubleLoans.end(), r.doubleLoans.begin(), r.doubleLoans.end());
+            report.orphans.insert(report.orphans.end(), r.orphans.begin(), r.orphans.end());
+            report.statusMismatches.insert(report.statusMismatches.end(), r.statusMismatches.begin(), r.statusMismatches.end());
+            report.duplicateBooks.insert(report.duplicateBooks.end(), r.duplicateBooks.begin(), r.duplicateBooks.end());
+            report.unrecordedLoans.insert(report.unrecordedLoans.end(), r.unrecordedLoans.begin(), r.unrecordedLoans.end());
+            report.changedBooks.insert(report.changedBooks.end(), r.changedBooks.begin(), r.changedBooks.end());
+            report.loansChecked += r.loansChecked;
+            report.historyChecked += r.historyChecked;
+            report.historyOrphans += r.historyOrphans;
+
+            for (const Release& release : part.releases) {
+                if (users[release.user]->getAccount().releaseBook(release.isbn, "Released", release.keepOne) > 0) {
+                    report.changedUsers.push_back(release.user);
+                }
+            }
         }
-    }    
+        sort(report.doubleLoans.begin(), report.doubleLoans.end());
+        sort(report.orphans.begin(), report.orphans.end());
+        sort(report.statusMismatches.begin(), report.statusMismatches.end());
+        sort(report.duplicateBooks.begin(), report.duplicateBooks.end());
+        sort(report.unrecordedLoans.begin(), report.unrecordedLoans.end());
+        sort(report.changedUsers.begin(), report.changedUsers.end());
+        report.changedUsers.erase(unique(report.changedUsers.begin(), report.changedUsers.end()), report.changedUsers.end());
+
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    static void print(const ConsistencyReport& report, size_t limit = 20) {
+        auto section = [limit](const string& title, const vector<string>& lines) {
+            cout << title << ": " << lines.size() << endl;
+            for (size_t i = 0; i < lines.size() && i < limit; i++) cout << "  " << lines[i] << endl;
+            if (lines.size() > limit) cout << "  ... " << lines.size() - limit << " more\n";
+        };
+        cout << "\nConsistency Check (" << report.loansChecked << " loans, " << report.historyChecked
+             << " history records, " << fixed << setprecision(2) << report.seconds << "s)\n";
+        cout.unsetf(ios::fixed);
+        section("Double loans", report.doubleLoans);
+        section("Orphaned loans", report.orphans);
+        section("Unrecorded loans", report.unrecordedLoans);
+        section("Status mismatches", report.statusMismatches);
+        section("Duplicate catalog entries (not repaired)", report.duplicateBooks);
+        cout << "Returned history for books no longer in the catalog: " << report.historyOrphans << endl;
+    }
+};
+
+class LibrarySystem {
+private:
+    vector<Book> books;
+    vector<unique_ptr<User>> users;
+    User* currentUser = nullptr;
+
+    ChangeStream changes;
+    bool readOnly = false; // leave the data files untouched on exit
+    size_t catalogStringBytes = 0, accountStringBytes = 0; // string pool growth while loading each file
+
+    void publishBook(const Book& book) { changes.publish("BOOK", book.serialize()); }
+    void publishUser(const User& user) { changes.publish("USER", serializeUser(user)); }
 
     void displayAvailableBooks() {
         cout << "\nAvailable Books:\n";
@@ -452,14 +1234,14 @@ private:
     }
 
     void displayBorrowedBooks() {
-        auto borrowed = currentUser->getAccount().getBorrowedBooks();
+        const auto& borrowed = currentUser->getAccount().getBorrowedBooks();
         if (borrowed.empty()) {
             cout << "No books currently borrowed.\n";
             return;
         }
         cout << "\nBorrowed Books:\n";
         for (const auto& entry : borrowed) {
-            cout << "ISBN: " << entry.first << " | Due Date: " << timeToString(entry.second) << endl;
+            cout << "ISBN: " << stringPool().get(entry.isbn) << " | Due Date: " << timeToString(entry.due) << endl;
         }
     }
 
@@ -474,6 +1256,10 @@ private:
                     [&isbn](const Book& b) { return b.getISBN() == isbn && b.getStatus() == "Available"; });
                 if (it != books.end()) {
                     currentUser->borrowBook(*it);
+                    if (it->getStatus() != "Available") {
+                        publishBook(*it);
+                        publishUser(*currentUser);
+                    }
                 } else {
                     cout << "Book not available or invalid ISBN.\n";
                 }
@@ -487,7 +1273,12 @@ private:
                 auto it = find_if(books.begin(), books.end(),
                     [&isbn](const Book& b) { return b.getISBN() == isbn; });
                 if (it != books.end()) {
+                    size_t borrowedBefore = currentUser->getAccount().getBorrowedBooks().size();
                     currentUser->returnBook(*it);
+                    if (currentUser->getAccount().getBorrowedBooks().size() != borrowedBefore) {
+                        publishBook(*it);
+                        publishUser(*currentUser);
+                    }
                 } else {
                     cout << "Book not found.\n";
                 }
@@ -501,23 +1292,22 @@ private:
                 cout << "Enter amount to pay: ";
                 cin >> amount;
                 currentUser->getAccount().payFine(amount);
+                publishUser(*currentUser);
                 cout << "Paid " << amount << " rupees. Remaining fines: " 
                      << currentUser->getAccount().getFine() << endl;
                 break;
             }
             case 5: { // View History (For Students)
-                auto history = currentUser->getAccount().getHistory();
+                const auto& history = currentUser->getAccount().getHistory();
                 if (history.empty()) {
                     cout << "No borrowing history.\n";
                     break;
                 }
                 cout << "\nBorrowing History:\n";
                 for (const auto& entry : history) {
-                    string isbn, dueDate, returnDate;
-                    stringstream ss(entry);
-                    getline(ss, isbn, '|');
-                    getline(ss, dueDate, '|');
-                    getline(ss, returnDate);
+                    string isbn = stringPool().get(entry.isbn);
+                    string dueDate = stringPool().get(entry.due);
+                    string returnDate = stringPool().get(entry.returned);
             
                     cout << "ISBN: " << isbn 
                          << " | Due: " << (dueDate.empty() ? "Not Available" : dueDate) 
@@ -543,6 +1333,10 @@ private:
                     [&isbn](const Book& b) { return b.getISBN() == isbn && b.getStatus() == "Available"; });
                 if (it != books.end()) {
                     currentUser->borrowBook(*it);
+                    if (it->getStatus() != "Available") {
+                        publishBook(*it);
+                        publishUser(*currentUser);
+                    }
                 } else {
                     cout << "Book not available or invalid ISBN.\n";
                 }
@@ -556,25 +1350,28 @@ private:
                 auto it = find_if(books.begin(), books.end(),
                     [&isbn](const Book& b) { return b.getISBN() == isbn; });
                 if (it != books.end()) {
+                    size_t borrowedBefore = currentUser->getAccount().getBorrowedBooks().size();
                     currentUser->returnBook(*it);
+                    if (currentUser->getAccount().getBorrowedBooks().size() != borrowedBefore) {
+                        publishBook(*it);
+                        publishUser(*currentUser);
+                    }
                 } else {
                     cout << "Book not found.\n";
                 }
                 break;
             }
             case 3: { // View History (For Faculty)
-                auto history = currentUser->getAccount().getHistory();
+                const auto& history = currentUser->getAccount().getHistory();
                 if (history.empty()) {
                     cout << "No borrowing history.\n";
                     break;
                 }
                 cout << "\nBorrowing History:\n";
                 for (const auto& entry : history) {
-                    string isbn, dueDate, returnDate;
-                    stringstream ss(entry);
-                    getline(ss, isbn, '|');
-                    getline(ss, dueDate, '|');
-                    getline(ss, returnDate);
+                    string isbn = stringPool().get(entry.isbn);
+                    string dueDate = stringPool().get(entry.due);
+                    string returnDate = stringPool().get(entry.returned);
             
                     cout << "ISBN: " << isbn 
                          << " | Due: " << (dueDate.empty() ? "Not Available" : dueDate) 
@@ -602,13 +1399,25 @@ private:
                 cout << "Enter ISBN: "; cin >> isbn;
                 cout << "Enter publication year: "; cin >> year;
                 lib->addBook(books, Book(title, author, publisher, isbn, year));
+                publishBook(books.back());
                 break;
             }
             case 2: {
                 string isbn;
                 cout << "Enter ISBN of the book to remove: ";
                 cin >> isbn;
+                StringId isbnId;
+                bool onLoan = stringPool().find(isbn, isbnId) &&
+                    any_of(users.begin(), users.end(), [isbnId](const unique_ptr<User>& u) {
+                        return u->getAccount().hasBorrowed(isbnId);
+                    });
+                if (onLoan) {
+                    cout << "Book is currently borrowed and cannot be removed.\n";
+                    break;
+                }
+                size_t countBefore = books.size();
                 lib->removeBook(books, isbn);
+                if (books.size() != countBefore) changes.publish("DELBOOK", isbn);
                 break;
             }
             case 3: {
@@ -622,14 +1431,20 @@ private:
                 if (typeChoice == 1) lib->addUser<Student>(users, name, id);
                 else if (typeChoice == 2) lib->addUser<Faculty>(users, name, id);
                 else if (typeChoice == 3) lib->addUser<Librarian>(users, name, id);
-                else cout << "Invalid type.\n";
+                else {
+                    cout << "Invalid type.\n";
+                    break;
+                }
+                publishUser(*users.back());
                 break;
             }
             case 4: {
                 int id;
                 cout << "Enter user ID to remove: ";
                 cin >> id;
+                size_t countBefore = users.size();
                 lib->removeUser(users, id);
+                if (users.size() != countBefore) changes.publish("DELUSER", to_string(id));
                 break;
             }
             case 5: {
@@ -651,6 +1466,7 @@ private:
                     cin >> newStatus;
                     if (newStatus == "Available" || newStatus == "Borrowed" || newStatus == "Reserved") {
                         it->setStatus(newStatus);
+                        publishBook(*it);
                         cout << "Status updated successfully.\n";
                     } else {
                         cout << "Invalid status! Use Available/Borrowed/Reserved.\n";
@@ -660,7 +1476,16 @@ private:
                 }
                 break;
             }
-            case 7:  // Updated exit condition
+            case 7: {
+                ConsistencyReport report = checkConsistency(false);
+                if (report.issueCount() == 0) break;
+                char answer;
+                cout << "Repair these issues? (y/n): ";
+                cin >> answer;
+                if (answer == 'y' || answer == 'Y') checkConsistency(true);
+                break;
+            }
+            case 8:  // Updated exit condition
                 cout << "Exiting Librarian Menu...\n";
                 break;
             default:
@@ -669,14 +1494,88 @@ private:
     }
 
 public:
-    LibrarySystem() {
-        loadBooks();
-        loadUsers();
+    // The log, not the snapshot, is the source of truth: anything published
+    // after the snapshot was saved (e.g. before a crash) is replayed on top of it.
+    LibrarySystem() : changes("changes.log") {
+        size_t poolBefore = stringPool().bytesUsed();
+        loadBooks("books.txt", books);
+        catalogStringBytes = stringPool().bytesUsed() - poolBefore;
+        loadUsers("users.txt", users);
+        accountStringBytes = stringPool().bytesUsed() - poolBefore - catalogStringBytes;
+
+        StreamOffset offset;
+        loadStreamOffset("changes.offset", offset);
+        // The index is only needed for the replay; later mutations go through
+        // the menus, which work on the vectors directly.
+        RecordIndex index;
+        index.rebuild(books, users);
+        long size = replayChanges("changes.log", offset, books, users, index);
+        // A torn final record (crash mid-write) was never applied by anyone;
+        // cut it off so the next record starts on a line of its own.
+        if (size > offset.bytes) {
+            cerr << "Discarding " << size - offset.bytes << " bytes of an incomplete change record.\n";
+            if (truncate("changes.log", offset.bytes) != 0) cerr << "Error truncating change stream changes.log\n";
+        }
+        changes.resumeAfter(offset);
     }
 
+    // The offset is written last so a replica never pairs a snapshot with an
+    // offset newer than it; replaying a few extra records is harmless.
     ~LibrarySystem() {
-        saveBooks();
-        saveUsers();
+        if (readOnly) return;
+        saveBooks("books.txt", books);
+        saveUsers("users.txt", users);
+        saveStreamOffset("changes.offset", changes.getHead());
+    }
+
+    // For offline tools that only inspect the data.
+    void setReadOnly() { readOnly = true; }
+
+    // Checks books against accounts; with repair, fixes what it finds and
+    // publishes the touched records to the change stream.
+    ConsistencyReport checkConsistency(bool repair, bool print = true) {
+        ConsistencyReport report = ConsistencyChecker::check(books, users, repair);
+        if (print) ConsistencyChecker::print(report);
+        if (repair) {
+            for (size_t index : report.changedBooks) publishBook(books[index]);
+            for (size_t index : report.changedUsers) publishUser(*users[index]);
+            cout << "Repaired " << report.changedBooks.size() << " books and "
+                 << report.changedUsers.size() << " accounts.\n";
+        }
+        return report;
+    }
+
+    // Where the memory goes, per record. The string pool is shared, so each side
+    // is charged with the pool bytes it used while loading; space reserved but
+    // not yet used is shown separately.
+    void printMemoryReport() {
+        size_t loans = 0, historyRecords = 0, recordBytes = 0;
+        for (const auto& user : users) {
+            loans += user->getAccount().getBorrowedBooks().size();
+            historyRecords += user->getAccount().getHistory().size();
+            recordBytes += user->getAccount().recordBytes();
+        }
+        size_t bookBytes = books.capacity() * sizeof(Book) + catalogStringBytes;
+        size_t userBytes = blockPool().bytesInUse() - recordBytes +
+                           users.capacity() * sizeof(unique_ptr<User>) + accountStringBytes;
+        size_t total = bookBytes + userBytes + recordBytes;
+        size_t rss = residentBytes();
+        auto perRecord = [](size_t bytes, size_t count) { return count ? bytes / (double)count : 0.0; };
+
+        cout << fixed << setprecision(1)
+             << "\nMemory Report\n"
+             << "Books:   " << books.size() << " x " << perRecord(bookBytes, books.size()) << " bytes\n"
+             << "Users:   " << users.size() << " x " << perRecord(userBytes, users.size()) << " bytes\n"
+             << "Loans:   " << loans + historyRecords << " x " << perRecord(recordBytes, loans + historyRecords)
+             << " bytes (" << loans << " current, " << historyRecords << " history)\n"
+             << "String pool: " << stringPool().size() << " distinct strings, "
+             << stringPool().bytesUsed() / 1048576.0 << " MiB used of "
+             << stringPool().bytesReserved() / 1048576.0 << " MiB\n"
+             << "Block pool: " << blockPool().bytesInUse() / 1048576.0 << " MiB in use of "
+             << blockPool().bytesReserved() / 1048576.0 << " MiB\n"
+             << "Accounted: " << total / 1048576.0 << " MiB | Resident: "
+             << (rss ? to_string(rss / 1048576) + " MiB" : string("unavailable")) << endl;
+        cout.unsetf(ios::fixed);
     }
 
     void login() {
@@ -711,13 +1610,260 @@ public:
 
             if ((currentUser->getType() == "Student" && choice == 6) || 
                 (currentUser->getType() == "Faculty" && choice == 4) || 
-                (currentUser->getType() == "Librarian" && choice == 7))
+                (currentUser->getType() == "Librarian" && choice == 8))
                 break;
         }
     }
 };
 
-int main() {
+// Read-only mirror of the primary. Bootstraps from a snapshot (its own, or the
+// primary's books.txt/users.txt) plus the stream offset that snapshot covers,
+// then tails changes.log before every query. Staleness is the time since the
+// replica last confirmed it had applied everything in the log.
+class ReplicaSystem {
+private:
+    vector<Book> books;
+    vector<unique_ptr<User>> users;
+    StreamOffset applied;
+    long pendingBytes = -1;    // log bytes not yet applied, or -1 if the log is unreadable
+    time_t lastSyncTime = 0;   // when the replica last reached the end of the log
+    int maxStaleness;          // seconds
+    RecordIndex index;         // kept in step with books/users by applyChange
+
+    vector<Book>::iterator findBook(const string& isbn) {
+        StringId id;
+        if (!stringPool().find(isbn, id)) return books.end();
+        auto found = index.books.find(id);
+        return found == index.books.end() ? books.end() : books.begin() + found->second;
+    }
+
+    vector<unique_ptr<User>>::iterator findUser(int id) {
+        auto found = index.users.find(id);
+        return found == index.users.end() ? users.end() : users.begin() + found->second;
+    }
+
+    void catchUp() {
+        long size = replayChanges("changes.log", applied, books, users, index);
+        // No log yet only counts as caught up if we never saw one.
+        pendingBytes = size < 0 ? (applied.bytes == 0 ? 0 : -1) : size - applied.bytes;
+        if (pendingBytes == 0) lastSyncTime = getCurrentTime();
+    }
+
+    // Seconds the replica may be missing primary changes: zero while it has
+    // applied the whole log, otherwise the time since it last had. -1 if it
+    // has never been caught up.
+    long staleness() const {
+        if (pendingBytes == 0) return 0;
+        return lastSyncTime ? (long)difftime(getCurrentTime(), lastSyncTime) : -1;
+    }
+
+    void refresh() {
+        catchUp();
+        long lag = staleness();
+        if (lag < 0 || lag > maxStaleness) {
+            cout << "Warning: replica " << (lag < 0 ? string("has not caught up with the change stream since it started")
+                                                    : "is " + to_string(lag) + "s behind the change stream")
+                 << " (bound " << maxStaleness << "s); results may be stale.\n";
+        }
+    }
+
+    void displayStatus() {
+        char when[32] = "None";
+        if (applied.time) strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&applied.time));
+        long lag = staleness();
+        cout << "\nReplica Status:\n"
+             << "Applied up to change: " << applied.seq << " (byte " << applied.bytes << ")\n"
+             << "Newest applied change: " << when;
+        if (applied.time) cout << " (" << (long)difftime(getCurrentTime(), applied.time) << "s ago)";
+        cout << "\nPending: " << (pendingBytes < 0 ? string("change stream unreadable") : to_string(pendingBytes) + " bytes")
+             << "\nStaleness: " << (lag < 0 ? string("unknown") : to_string(lag) + "s")
+             << " | Bound: " << maxStaleness << "s\n";
+    }
+
+    void displayBooks(bool availableOnly) {
+        cout << (availableOnly ? "\nAvailable Books:\n" : "\nAll Books:\n");
+        for (const auto& book : books) {
+            if (availableOnly && book.getStatus() != "Available") continue;
+            cout << "ISBN: " << book.getISBN() << " | Title: " << book.getTitle()
+                 << " | Author: " << book.getAuthor() << " | Status: " << book.getStatus() << endl;
+        }
+    }
+
+    void displayHistory(int id) {
+        auto it = findUser(id);
+        if (it == users.end()) {
+            cout << "User not found.\n";
+            return;
+        }
+        const auto& history = (*it)->getAccount().getHistory();
+        if (history.empty()) {
+            cout << "No borrowing history.\n";
+            return;
+        }
+        cout << "\nBorrowing History for " << (*it)->getName() << ":\n";
+        for (const auto& entry : history) {
+            string isbn = stringPool().get(entry.isbn);
+            string dueDate = stringPool().get(entry.due);
+            string returnDate = stringPool().get(entry.returned);
+            cout << "ISBN: " << isbn
+                 << " | Due: " << (dueDate.empty() ? "Not Available" : dueDate)
+                 << " | Returned: " << returnDate << endl;
+        }
+    }
+
+public:
+    ReplicaSystem(int maxStalenessSeconds) : maxStaleness(maxStalenessSeconds) {
+        if (loadStreamOffset("replica.offset", applied)) {
+            loadBooks("replica_books.txt", books);
+            loadUsers("replica_users.txt", users);
+        } else {
+            applied = StreamOffset();
+            loadStreamOffset("changes.offset", applied);
+            loadBooks("books.txt", books);
+            loadUsers("users.txt", users);
+        }
+        index.rebuild(books, users);
+        catchUp();
+    }
+
+    ~ReplicaSystem() {
+        saveBooks("replica_books.txt", books);
+        saveUsers("replica_users.txt", users);
+        saveStreamOffset("replica.offset", applied);
+    }
+
+    void run() {
+        while (true) {
+            cout << "\nReplica Menu (read-only)\n1. List Available Books\n2. List All Books\n3. Check Availability\n"
+                 << "4. View User History\n5. Replica Status\n6. Exit\nChoice: ";
+            int choice;
+            if (!(cin >> choice) || choice == 6) break;
+            refresh();
+            switch (choice) {
+                case 1:
+                    displayBooks(true);
+                    break;
+                case 2:
+                    displayBooks(false);
+                    break;
+                case 3: {
+                    string isbn;
+                    cout << "Enter ISBN: ";
+                    cin >> isbn;
+                    auto it = findBook(isbn);
+                    if (it != books.end()) cout << it->getTitle() << ": " << it->getStatus() << endl;
+                    else cout << "Book not found.\n";
+                    break;
+                }
+                case 4: {
+                    int id;
+                    cout << "Enter user ID: ";
+                    cin >> id;
+                    displayHistory(id);
+                    break;
+                }
+                case 5:
+                    displayStatus();
+                    break;
+                default:
+                    cout << "Invalid choice.\n";
+            }
+        }
+    }
+};
+
+// Writes a synthetic books.txt/users.txt into dir for load and consistency
+// testing. Loans are handed out in catalog order so the data starts out
+// consistent, except for one double loan and one orphan seeded every
+// 100000 users so the checker has something to find.
+void generateDataset(const string& dir, long bookCount, long userCount) {
+    const long day = 24 * 60 * 60;
+    time_t now = getCurrentTime();
+    srand(253);
+
+    vector<bool> onLoan(bookCount, false);
+    long nextBook = 0, loans = 0, history = 0;
+
+    ofstream usersFile(dir + "/users.txt");
+    for (long u = 0; u < userCount; u++) {
+        string type = u % 1000 == 999 ? "Librarian" : (u % 10 == 9 ? "Faculty" : "Student");
+        int maxBooks = type == "Faculty" ? 5 : (type == "Student" ? 3 : 0);
+        int period = type == "Faculty" ? 30 : 15;
+
+        vector<pair<string, time_t>> borrowed;
+        vector<string> past;
+        for (int i = 0; i < maxBooks && nextBook < bookCount; i++, nextBook++) {
+            onLoan[nextBook] = true;
+            borrowed.emplace_back("ISBN" + to_string(100000 + nextBook), now + (rand() % period) * day);
+        }
+        if (maxBooks > 0 && u % 100000 == 0 && nextBook > 0) {
+            borrowed.emplace_back("ISBN" + to_string(100000 + rand() % nextBook), now + period * day);
+            borrowed.emplace_back("ISBN-GONE-" + to_string(u), now + period * day);
+        }
+        for (int i = 0; i < 2 && maxBooks > 0 && bookCount > 0; i++) {
+            time_t due = now - (rand() % 365 + 30) * day;
+            past.push_back("ISBN" + to_string(100000 + rand() % bookCount) + "|" + timeToString(due) + "|" +
+                           timeToString(due - (rand() % period) * day));
+        }
+
+        usersFile << type << "|User " << u << "|" << (100000 + u) << "|" << borrowed.size() << ";";
+        for (const auto& entry : borrowed) usersFile << entry.first << "," << entry.second << ";";
+        usersFile << borrowed.size() + past.size() << ";";
+        for (const auto& entry : borrowed) usersFile << entry.first << "|" << timeToString(entry.second) << "|Not Returned;";
+        for (const auto& entry : past) usersFile << entry << ";";
+        usersFile << "0;\n";
+        loans += borrowed.size();
+        history += borrowed.size() + past.size();
+    }
+
+    // A few hundred authors and publishers, as in a real catalog.
+    ofstream booksFile(dir + "/books.txt");
+    for (long b = 0; b < bookCount; b++) {
+        booksFile << "ISBN" << (100000 + b) << ",Book " << b << ",Author " << rand() % 500
+                  << ",Publisher " << rand() % 50 << "," << 1950 + rand() % 75 << ","
+                  << (onLoan[b] ? "Borrowed" : (b % 50 == 0 ? "Reserved" : "Available")) << "\n";
+    }
+
+    cout << "Generated " << bookCount << " books and " << userCount << " users with "
+         << loans << " loans and " << history << " history records in " << dir << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--replica") {
+        ReplicaSystem replica(argc > 2 ? atoi(argv[2]) : 5);
+        replica.run();
+        return 0;
+    }
+    if (mode == "--generate") {
+        if (argc < 5) {
+            cerr << "Usage: " << argv[0] << " --generate <dir> <books> <users>\n";
+            return 1;
+        }
+        generateDataset(argv[2], atol(argv[3]), atol(argv[4]));
+        return 0;
+    }
+    if (mode == "--memory") {
+        LibrarySystem system;
+        system.setReadOnly();
+        system.printMemoryReport();
+        return 0;
+    }
+    if (mode == "--check") {
+        bool repair = argc > 2 && string(argv[2]) == "--repair";
+        LibrarySystem system;
+        if (!repair) {
+            system.setReadOnly();
+            return system.checkConsistency(false).issueCount() == 0 ? 0 : 2;
+        }
+        // Exit status reflects what is left after the repair, i.e. duplicate
+        // catalog entries, which are reported but not repaired.
+        system.checkConsistency(true);
+        size_t remaining = system.checkConsistency(false, false).issueCount();
+        if (remaining > 0) cout << remaining << " issues could not be repaired.\n";
+        return remaining == 0 ? 0 : 2;
+    }
+
     LibrarySystem system;
     system.login();
     system.run();